@@ -3,6 +3,7 @@
 //by using Astar, Greedy and Uniform search
 
 #include<iostream>
+#include<fstream>
 #include<list>
 #include<map>
 #include<queue>
@@ -10,6 +11,18 @@
 #include<math.h>
 #include<string.h>
 #include<limits.h>
+#include<float.h>
+#include<stdint.h>
+#include<stdlib.h>
+#include<stdio.h>
+#include<unistd.h>
+#include<vector>
+#include<algorithm>
+#include<chrono>
+#include<thread>
+#include<atomic>
+#include<mutex>
+#include<condition_variable>
 
 using namespace std;
 
@@ -17,6 +30,31 @@ using namespace std;
 #define GREY 1
 #define BLACK 2
 
+//graphs with at most this many nodes answer astar and uniform queries
+//from a precomputed all pairs table, can be overridden with the
+//SEARCHUSA_ALL_PAIRS_THRESHOLD environment variable (0 disables it)
+#define ALL_PAIRS_THRESHOLD 256
+#define ALL_PAIRS_TILE 32
+#define ALL_PAIRS_FILE "allPairs.bin"
+#define ALL_PAIRS_MAGIC "APSP"
+
+//delta stepping bin width as a multiple of the mean edge weight, frontier
+//entries handed to a thread at a time, and the bin size up to which a
+//thread keeps relaxing its own entries without synchronizing
+#define DELTA_STEPPING_FACTOR 4
+#define DELTA_STEPPING_CHUNK 64
+#define DELTA_STEPPING_LOCAL_LIMIT 1000
+
+//largest cell of the lowest overlay level for synthetic and for the built
+//in graph, bisection steps per overlay level (4 subcells per cell), the
+//largest cell of any level and the distance between crossings of the
+//overlay benchmark road graph
+#define OVERLAY_CELL_SIZE 512
+#define OVERLAY_USA_CELL_SIZE 8
+#define OVERLAY_LEVEL_BITS 2
+#define OVERLAY_MAX_CELL_SIZE 32768
+#define OVERLAY_ROAD_SPACING 8
+
 void createGraph();
 void addEdge(string u, string v, float distance);
 void createLocationMap();
@@ -63,12 +101,258 @@ public:
     }
 };
 
+//undirected edge between two integer node ids, used while building
+//the integer indexed graphs below
+struct edgeRecord
+{
+	int u;
+	int v;
+	float distance;
+};
+
+//integer indexed copy of a graph in compressed sparse row form. The
+//neighbours of node u are edgeTarget[firstEdge[u] .. firstEdge[u+1]-1].
+//nodeName is empty for synthetic graphs
+struct indexedGraph
+{
+	vector<int> firstEdge;
+	vector<int> edgeTarget;
+	vector<float> edgeWeight;
+	vector<cityLocation> location;
+	vector<string> nodeName;
+	map<string, int> nodeIndex;
+};
+
+//compressed graph. The weight of every undirected edge is stored once,
+//in the list of its lower numbered end point, as a varint pair (id
+//delta, quantized weight). The higher numbered end point only keeps a
+//varint delta list of its lower numbered neighbours; their weights are
+//looked up in the neighbours' own lists while decoding.
+//location, nodeName and nodeIndex are copied from the indexed graph, so
+//that it can be freed once compressed
+struct compressedGraph
+{
+	int numNodes;
+	long long numEdges;
+	float weightQuantum;
+	vector<uint32_t> upperStart;
+	vector<uint8_t> upperBytes;
+	vector<uint32_t> lowerStart;
+	vector<uint8_t> lowerBytes;
+	vector<cityLocation> location;
+	vector<string> nodeName;
+	map<string, int> nodeIndex;
+};
+
+//all pairs shortest distances of an indexed graph in row major order.
+//nextHop[u*numNodes+v] is the node after u on the shortest path to v,
+//dist is FLT_MAX and nextHop -1 when v is not reachable from u
+struct allPairsTable
+{
+	int numNodes;
+	vector<float> dist;
+	vector<int> nextHop;
+};
+
+//path found by the k shortest paths search. deviation is the index of
+//the spur node it was found from
+struct rankedPath
+{
+	float distance;
+	int deviation;
+	vector<int> nodes;
+};
+
+//per thread search buffers, dist is kept at FLT_MAX between searches by
+//resetting only the touched nodes. blocked is only used by spur searches
+struct searchWorkspace
+{
+	vector<float> dist;
+	vector<int> parent;
+	vector<char> blocked;
+	vector<int> touched;
+};
+
+//data shared by the threads running the spur searches of one path
+struct spurTask
+{
+	indexedGraph *g;
+	vector<float> *distToTarget;
+	vector<int> *towardTarget;
+	vector<rankedPath> *accepted;
+	vector<searchWorkspace> *workspaces;
+	vector<float> *rootDist;
+	vector<rankedPath> *spurPaths;
+	int destination;
+	int firstSpur;
+	int numThreads;
+	bool reuseTree;
+};
+
+//reusable barrier for a fixed number of threads
+struct threadBarrier
+{
+	mutex lock;
+	condition_variable released;
+	int numThreads;
+	int waiting;
+	int generation;
+};
+
+//data shared by the threads of one delta stepping search. packed holds
+//the tentative distance and parent of every node, frontier the nodes of
+//the bin being settled
+struct deltaSteppingTask
+{
+	indexedGraph *g;
+	int root;
+	float delta;
+	int numThreads;
+	vector< atomic<uint64_t> > packed;
+	vector<int> frontier;
+	atomic<size_t> nextIndex;
+	size_t currentBin;
+	atomic<size_t> nextBin;
+	vector<size_t> binCount;
+	threadBarrier barrier;
+	vector<float> *dist;
+	vector<int> *parent;
+
+	deltaSteppingTask(int numNodes, int threads) : numThreads(threads), packed(numNodes), binCount(threads)
+	{
+		barrier.numThreads = threads;
+		barrier.waiting = 0;
+		barrier.generation = 0;
+	}
+};
+
+void buildAdjacency(indexedGraph &g, int numNodes, vector<edgeRecord> &edges);
+void buildIndexedGraph(indexedGraph &g);
+void createSyntheticGraph(indexedGraph &g, int side, unsigned int seed);
+void createRoadGraph(indexedGraph &g, int side, int spacing, unsigned int seed);
+float geoDistance(cityLocation a, cityLocation b);
+void compressGraph(indexedGraph &g, compressedGraph &cg, float weightQuantum);
+long long compressedBytes(compressedGraph &cg);
+void decodeNeighbours(compressedGraph &cg, int node, vector<int> &ids, vector<float> &weights);
+float compressedShortestPath(compressedGraph &cg, int source, int destination,
+	bool useHeuristic, vector<int> &parent, int &nodesExpanded);
+float indexedShortestPath(indexedGraph &g, int source, int destination,
+	bool useHeuristic, vector<int> &parent, int &nodesExpanded);
+list<string> compressedSearch(string source, string destination);
+float mapShortestPath(string source, string destination);
+void compressBenchmark(int side, int numQueries);
+edgeRecord syntheticEdge(indexedGraph &g, int u, int v);
+double elapsedMs(chrono::steady_clock::time_point start);
+uint64_t graphChecksum(indexedGraph &g);
+void floydWarshallTile(allPairsTable &table, int iBlock, int jBlock, int kBlock);
+void computeAllPairs(indexedGraph &g, allPairsTable &table);
+bool saveAllPairs(allPairsTable &table, uint64_t checksum, string fileName);
+bool loadAllPairs(allPairsTable &table, uint64_t checksum, int numNodes, string fileName);
+void loadOrComputeAllPairs(indexedGraph &g, allPairsTable &table);
+list<string> allPairsSearch(string source, string destination);
+void precomputeAllPairs();
+void shortestPathTree(indexedGraph &g, int root, vector<float> &dist, vector<int> &parent, int destination = -1);
+float indexedEdgeWeight(indexedGraph &g, int u, int v);
+bool spurSearch(spurTask &task, searchWorkspace &ws, int spur, vector<int> &blockedNext, vector<int> &spurPath, float &spurDist);
+void spurWorker(spurTask *task, int threadIndex);
+void kShortestPaths(indexedGraph &g, int source, int destination, int k, bool reuseTree,
+	int numThreads, vector<rankedPath> &paths);
+int defaultThreadCount();
+void kShortestSearch(string source, string destination, int k);
+void kShortestBenchmark(int side, int k);
+void barrierWait(threadBarrier &barrier);
+uint64_t packDistance(float dist, int parent);
+float unpackDistance(uint64_t packed);
+void deltaSteppingRelax(deltaSteppingTask *task, int node, vector< vector<int> > &bins);
+void deltaSteppingWorker(deltaSteppingTask *task, int threadIndex);
+void deltaSteppingTree(indexedGraph &g, int root, float delta, int numThreads,
+	vector<float> &dist, vector<int> &parent);
+float defaultDelta(indexedGraph &g);
+void oneToAllSearch(string source);
+void oneToAllBenchmark(int side, int maxThreads);
+
+//orders node ids by latitude or longitude for the geometric partition
+class locationCompare
+{
+public:
+	indexedGraph *g;
+	bool byLatitude;
+
+	bool operator() (int a, int b)
+	{
+		if(byLatitude)
+			return g->location[a].latitude < g->location[b].latitude;
+		return g->location[a].longitude < g->location[b].longitude;
+	}
+};
+
+//one level of the multi level overlay. cell gives the cell of every node,
+//boundary the nodes of each cell with an edge leaving it and clique the
+//shortcut weights between them in row major order, indexed through
+//boundaryIndex. dirty cells need customization, changed marks the cells
+//whose shortcuts changed in the last customization. customizeMs and
+//customizedCells describe the last customization of the level
+struct overlayLevel
+{
+	int numCells;
+	vector<int> cell;
+	vector< vector<int> > boundary;
+	vector<int> boundaryIndex;
+	vector< vector<float> > clique;
+	vector<char> dirty;
+	vector<char> changed;
+	double customizeMs;
+	int customizedCells;
+};
+
+//levels[0] has the smallest cells, every cell of a level is a union of
+//cells of the level below. The remaining members are the buffers of the
+//forward (0) and backward (1) query searches and of shortcut unpacking
+struct overlayGraph
+{
+	indexedGraph *g;
+	vector<overlayLevel> levels;
+	vector<float> dist[2];
+	vector<int> parent[2];
+	vector<int> parentLevel[2];
+	vector<int> touched[2];
+	searchWorkspace unpack;
+};
+
+//data shared by the threads customizing one overlay level
+struct customizeTask
+{
+	overlayGraph *overlay;
+	int level;
+	vector<searchWorkspace> *workspaces;
+	atomic<int> nextCell;
+};
+
+typedef priority_queue< pair<float, int>, vector< pair<float, int> >, greater< pair<float, int> > > overlayQueue;
+
+void partitionNodes(indexedGraph &g, vector<int> &order, int begin, int end, int depth, int code, vector<int> &cellCode);
+void buildOverlay(overlayGraph &overlay, indexedGraph &g, int cellSize);
+void customizeCell(overlayGraph &overlay, int level, int cell, searchWorkspace &ws);
+void customizeWorker(customizeTask *task, int threadIndex);
+int customizeOverlay(overlayGraph &overlay, int numThreads);
+void updateOverlayWeight(overlayGraph &overlay, int u, int v, float distance);
+int queryLevel(overlayGraph &overlay, int node, int source, int destination);
+void overlayRelax(overlayGraph &overlay, int dir, int node, int v, float distance, int level,
+	overlayQueue &pqueue, float &bestDist, int &meetNode);
+void cellPath(overlayGraph &overlay, int level, int a, int b, vector<int> &path);
+float overlayQuery(overlayGraph &overlay, int source, int destination, vector<int> *path);
+list<string> overlaySearch(string source, string destination);
+void printCustomization(overlayGraph &overlay);
+int overlayQueries(overlayGraph &overlay, vector< pair<int, int> > &queries, double &overlayMs, double &uniformMs);
+void overlayBenchmark(int side, int numQueries);
+
 //graph to store a node and info of its adjacent nodes
 map< string, list<neighbourInfo> > graph;
 
 //map to store laitude and logitude of a location
 map<string, cityLocation> cityLocationMap;
 int totalDistance = 0;
+int allPairsThreshold = ALL_PAIRS_THRESHOLD;
 
 
 int main(int argc, char *argv[])
@@ -81,13 +365,43 @@ int main(int argc, char *argv[])
 	createLocationMap();
 	list<string> outputPath;
 
+	if(getenv("SEARCHUSA_ALL_PAIRS_THRESHOLD") != NULL)
+		allPairsThreshold = atoi(getenv("SEARCHUSA_ALL_PAIRS_THRESHOLD"));
+
+	if(argc == 2 && strcmp(argv[1], "precompute") == 0)
+	{
+		precomputeAllPairs();
+		return 0;
+	}
+
+	//k shortest paths take the number of paths as an optional argument
+	if((argc == 4 || argc == 5) && strcmp(argv[1], "kshortest") == 0)
+	{
+		kShortestSearch(argv[2], argv[3], argc == 5 ? atoi(argv[4]) : 3);
+		return 0;
+	}
+
+	if(argc == 3 && strcmp(argv[1], "onetoall") == 0)
+	{
+		oneToAllSearch(argv[2]);
+		return 0;
+	}
+
 	if(argc != 4)
 	{
 		cout<<"Please enter proper number of command line arguments\n";
 		return 1;
 	}
 
-	if(strcmp(argv[1], "astar") == 0)
+	//small graphs are answered from the all pairs table instead
+	//of searching, both algorithms return shortest paths
+	if((strcmp(argv[1], "astar") == 0 || strcmp(argv[1], "uniform") == 0)
+		&& (int)graph.size() <= allPairsThreshold)
+	{
+		outputPath = allPairsSearch(argv[2], argv[3]);
+		printOutPath(outputPath);
+	}
+	else if(strcmp(argv[1], "astar") == 0)
 	{
 		outputPath = astar(argv[2], argv[3]);
 		printOutPath(outputPath);
@@ -100,11 +414,41 @@ int main(int argc, char *argv[])
 	else if(strcmp(argv[1], "uniform") == 0)
 	{
 		outputPath = uniform(argv[2], argv[3]);
-		printOutPath(outputPath);	
+		printOutPath(outputPath);
+	}
+	else if(strcmp(argv[1], "compressed") == 0)
+	{
+		outputPath = compressedSearch(argv[2], argv[3]);
+		printOutPath(outputPath);
+	}
+	else if(strcmp(argv[1], "compressbench") == 0)
+	{
+		//arguments are the side of the synthetic grid and the number of queries
+		compressBenchmark(atoi(argv[2]), atoi(argv[3]));
+	}
+	else if(strcmp(argv[1], "kshortestbench") == 0)
+	{
+		//arguments are the side of the synthetic grid and k
+		kShortestBenchmark(atoi(argv[2]), atoi(argv[3]));
+	}
+	else if(strcmp(argv[1], "overlay") == 0)
+	{
+		outputPath = overlaySearch(argv[2], argv[3]);
+		printOutPath(outputPath);
+	}
+	else if(strcmp(argv[1], "overlaybench") == 0)
+	{
+		//arguments are the side of the synthetic grid and the number of queries
+		overlayBenchmark(atoi(argv[2]), atoi(argv[3]));
+	}
+	else if(strcmp(argv[1], "onetoallbench") == 0)
+	{
+		//arguments are the side of the synthetic grid and the maximum number of threads
+		oneToAllBenchmark(atoi(argv[2]), atoi(argv[3]));
 	}
 	else
 	{
-		cout<<"Please enter proper search type i.e either astar, greedy or uniform (case sensetive)\n";
+		cout<<"Please enter proper search type i.e either astar, greedy, uniform, compressed, compressbench, precompute, kshortest, kshortestbench, onetoall, onetoallbench, overlay or overlaybench (case sensetive)\n";
 		return 2;
 	}
 
@@ -466,32 +810,1987 @@ list<string> uniform(string source, string destination)
 	return emptyPath;
 }
 
-void addEdge(string u, string v, float distance)
+//builds the compressed sparse row adjacency of g from a list of
+//undirected edges, every edge is inserted in both directions
+void buildAdjacency(indexedGraph &g, int numNodes, vector<edgeRecord> &edges)
 {
-	neighbourInfo neighbourInfoVar;
-	neighbourInfoVar.cityName = v;
-	neighbourInfoVar.distance = distance;
-	graph[u].push_back(neighbourInfoVar);
+	g.firstEdge.assign(numNodes + 1, 0);
+	for(size_t i=0; i<edges.size(); i++)
+	{
+		g.firstEdge[edges[i].u + 1]++;
+		g.firstEdge[edges[i].v + 1]++;
+	}
+	for(int node=0; node<numNodes; node++)
+		g.firstEdge[node + 1] += g.firstEdge[node];
 
-	neighbourInfoVar.cityName = u;
-	graph[v].push_back(neighbourInfoVar);
+	g.edgeTarget.resize(2 * edges.size());
+	g.edgeWeight.resize(2 * edges.size());
+	vector<int> nextSlot(g.firstEdge.begin(), g.firstEdge.end() - 1);
+	for(size_t i=0; i<edges.size(); i++)
+	{
+		g.edgeTarget[nextSlot[edges[i].u]] = edges[i].v;
+		g.edgeWeight[nextSlot[edges[i].u]++] = edges[i].distance;
+		g.edgeTarget[nextSlot[edges[i].v]] = edges[i].u;
+		g.edgeWeight[nextSlot[edges[i].v]++] = edges[i].distance;
+	}
 }
 
-void addLocation(string cityName, float latitude, float longitude)
+//numbers the cities of the global graph in alphabetical order and
+//builds the integer indexed copy of it
+void buildIndexedGraph(indexedGraph &g)
 {
-	cityLocation cityLocationVar;
-	cityLocationVar.latitude = latitude;
-	cityLocationVar.longitude = longitude;
-	cityLocationMap[cityName] = cityLocationVar;
+	map< string, list<neighbourInfo> >::iterator graphItr;
+	list<neighbourInfo>::iterator neighbourItr;
+	vector<edgeRecord> edges;
+
+	g.nodeName.clear();
+	g.nodeIndex.clear();
+	g.location.clear();
+	for(graphItr=graph.begin(); graphItr!=graph.end(); graphItr++)
+	{
+		g.nodeIndex[graphItr->first] = g.nodeName.size();
+		g.nodeName.push_back(graphItr->first);
+		g.location.push_back(cityLocationMap[graphItr->first]);
+	}
+
+	//graph holds both directions of every edge, keep only one of them
+	for(graphItr=graph.begin(); graphItr!=graph.end(); graphItr++)
+	{
+		int u = g.nodeIndex[graphItr->first];
+		for(neighbourItr=graphItr->second.begin(); neighbourItr!=graphItr->second.end(); neighbourItr++)
+		{
+			edgeRecord edge;
+			edge.u = u;
+			edge.v = g.nodeIndex[(*neighbourItr).cityName];
+			edge.distance = (*neighbourItr).distance;
+			if(edge.u < edge.v)
+				edges.push_back(edge);
+		}
+	}
+
+	buildAdjacency(g, g.nodeName.size(), edges);
 }
 
-float calculateHeuristic(string source, string destination)
+edgeRecord syntheticEdge(indexedGraph &g, int u, int v)
+{
+	//road distance is the straight line distance stretched by up to 50%,
+	//rounded up to 1/16 mile so the heuristic stays admissible
+	edgeRecord edge;
+	edge.u = u;
+	edge.v = v;
+	edge.distance = geoDistance(g.location[u], g.location[v]) * (1.0 + (rand() % 50) / 100.0);
+	edge.distance = ceil(edge.distance * 16.0) / 16.0;
+	return edge;
+}
+
+//creates a side x side grid of nodes spread over the continental USA.
+//Every node is connected to its right and lower neighbour and to the
+//lower right one with probability 1/4
+void createSyntheticGraph(indexedGraph &g, int side, unsigned int seed)
+{
+	int numNodes = side * side;
+	vector<edgeRecord> edges;
+
+	srand(seed);
+	g.nodeName.clear();
+	g.nodeIndex.clear();
+	g.location.resize(numNodes);
+	for(int row=0; row<side; row++)
+	{
+		for(int col=0; col<side; col++)
+		{
+			g.location[row * side + col].latitude = 25.0 + 24.0 * row / side;
+			g.location[row * side + col].longitude = 70.0 + 54.0 * col / side;
+		}
+	}
+
+	edges.reserve(2.25 * numNodes);
+	for(int row=0; row<side; row++)
+	{
+		for(int col=0; col<side; col++)
+		{
+			int u = row * side + col;
+			if(col + 1 < side)
+				edges.push_back(syntheticEdge(g, u, u + 1));
+			if(row + 1 < side)
+				edges.push_back(syntheticEdge(g, u, u + side));
+			if(row + 1 < side && col + 1 < side && rand() % 4 == 0)
+				edges.push_back(syntheticEdge(g, u, u + side + 1));
+		}
+	}
+
+	buildAdjacency(g, numNodes, edges);
+}
+
+//creates a thinned side x side grid that looks more like a road network:
+//only the nodes on every spacing-th row and column are kept, so roads
+//are long chains of nodes and crossings are spacing nodes apart
+void createRoadGraph(indexedGraph &g, int side, int spacing, unsigned int seed)
+{
+	vector<int> nodeId((size_t)side * side, -1);
+	vector<edgeRecord> edges;
+	int numNodes = 0;
+
+	srand(seed);
+	g.nodeName.clear();
+	g.nodeIndex.clear();
+	g.location.clear();
+	for(int row=0; row<side; row++)
+	{
+		for(int col=0; col<side; col++)
+		{
+			if(row % spacing != 0 && col % spacing != 0)
+				continue;
+			cityLocation location;
+			location.latitude = 25.0 + 24.0 * row / side;
+			location.longitude = 70.0 + 54.0 * col / side;
+			g.location.push_back(location);
+			nodeId[(size_t)row * side + col] = numNodes++;
+		}
+	}
+
+	for(int row=0; row<side; row++)
+	{
+		for(int col=0; col<side; col++)
+		{
+			int u = nodeId[(size_t)row * side + col];
+			if(u == -1)
+				continue;
+			if(row % spacing == 0 && col + 1 < side)
+				edges.push_back(syntheticEdge(g, u, nodeId[(size_t)row * side + col + 1]));
+			if(col % spacing == 0 && row + 1 < side)
+				edges.push_back(syntheticEdge(g, u, nodeId[(size_t)(row + 1) * side + col]));
+		}
+	}
+
+	buildAdjacency(g, numNodes, edges);
+}
+
+void putVarint(vector<uint8_t> &bytes, uint32_t value)
+{
+	while(value >= 0x80)
+	{
+		bytes.push_back((uint8_t)(value | 0x80));
+		value >>= 7;
+	}
+	bytes.push_back((uint8_t)value);
+}
+
+uint32_t getVarint(const uint8_t *&bytes)
+{
+	uint32_t value = 0;
+	int shift = 0;
+	while(*bytes & 0x80)
+	{
+		value |= (uint32_t)(*bytes & 0x7f) << shift;
+		shift += 7;
+		bytes++;
+	}
+	value |= (uint32_t)(*bytes) << shift;
+	bytes++;
+	return value;
+}
+
+//compresses g. Weights are rounded to multiples of weightQuantum, which
+//is lossless when all weights already are such multiples. Parallel edges
+//are merged keeping the shortest one and self loops are dropped since
+//neither can be part of a shortest path
+void compressGraph(indexedGraph &g, compressedGraph &cg, float weightQuantum)
+{
+	int numNodes = g.firstEdge.size() - 1;
+	vector< pair<int, float> > upper;
+	vector<int> lower;
+
+	cg.numNodes = numNodes;
+	cg.numEdges = 0;
+	cg.weightQuantum = weightQuantum;
+	cg.upperStart.clear();
+	cg.upperBytes.clear();
+	cg.lowerStart.clear();
+	cg.lowerBytes.clear();
+	cg.location = g.location;
+	cg.nodeName = g.nodeName;
+	cg.nodeIndex = g.nodeIndex;
+
+	for(int u=0; u<numNodes; u++)
+	{
+		upper.clear();
+		lower.clear();
+		for(int e=g.firstEdge[u]; e<g.firstEdge[u + 1]; e++)
+		{
+			if(g.edgeTarget[e] > u)
+				upper.push_back(make_pair(g.edgeTarget[e], g.edgeWeight[e]));
+			else if(g.edgeTarget[e] < u)
+				lower.push_back(g.edgeTarget[e]);
+		}
+
+		//ascending ids, the first of a run of parallel edges is the shortest
+		sort(upper.begin(), upper.end());
+		cg.upperStart.push_back(cg.upperBytes.size());
+		int previous = u;
+		for(size_t i=0; i<upper.size(); i++)
+		{
+			if(i > 0 && upper[i].first == upper[i - 1].first)
+				continue;
+			putVarint(cg.upperBytes, upper[i].first - previous);
+			putVarint(cg.upperBytes, (uint32_t)floor(upper[i].second / weightQuantum + 0.5));
+			previous = upper[i].first;
+			cg.numEdges++;
+		}
+
+		//descending ids so that the deltas are taken from u downwards
+		sort(lower.rbegin(), lower.rend());
+		lower.erase(unique(lower.begin(), lower.end()), lower.end());
+		cg.lowerStart.push_back(cg.lowerBytes.size());
+		previous = u;
+		for(size_t i=0; i<lower.size(); i++)
+		{
+			putVarint(cg.lowerBytes, previous - lower[i]);
+			previous = lower[i];
+		}
+	}
+	cg.upperStart.push_back(cg.upperBytes.size());
+	cg.lowerStart.push_back(cg.lowerBytes.size());
+}
+
+long long compressedBytes(compressedGraph &cg)
+{
+	return cg.upperBytes.size() + cg.lowerBytes.size()
+		+ (cg.upperStart.size() + cg.lowerStart.size()) * sizeof(uint32_t);
+}
+
+//weight of the edge between low and high (low < high), stored in the
+//list of low
+float compressedEdgeWeight(compressedGraph &cg, int low, int high)
+{
+	const uint8_t *bytes = &cg.upperBytes[0] + cg.upperStart[low];
+	const uint8_t *end = &cg.upperBytes[0] + cg.upperStart[low + 1];
+	int id = low;
+
+	while(bytes < end)
+	{
+		id += getVarint(bytes);
+		uint32_t weight = getVarint(bytes);
+		if(id == high)
+			return weight * cg.weightQuantum;
+	}
+	return -1;
+}
+
+//decodes all neighbours of node and the weights of the connecting edges
+void decodeNeighbours(compressedGraph &cg, int node, vector<int> &ids, vector<float> &weights)
+{
+	const uint8_t *bytes, *end;
+	int id;
+
+	ids.clear();
+	weights.clear();
+
+	bytes = cg.upperBytes.empty() ? NULL : &cg.upperBytes[0] + cg.upperStart[node];
+	end = cg.upperBytes.empty() ? NULL : &cg.upperBytes[0] + cg.upperStart[node + 1];
+	id = node;
+	while(bytes < end)
+	{
+		id += getVarint(bytes);
+		ids.push_back(id);
+		weights.push_back(getVarint(bytes) * cg.weightQuantum);
+	}
+
+	bytes = cg.lowerBytes.empty() ? NULL : &cg.lowerBytes[0] + cg.lowerStart[node];
+	end = cg.lowerBytes.empty() ? NULL : &cg.lowerBytes[0] + cg.lowerStart[node + 1];
+	id = node;
+	while(bytes < end)
+	{
+		id -= getVarint(bytes);
+		ids.push_back(id);
+		weights.push_back(compressedEdgeWeight(cg, id, node));
+	}
+}
+
+//Astar (or uniform cost search when useHeuristic is false) over the
+//compressed graph, neighbours are decoded when a node is expanded.
+//Returns the distance to destination or -1 if it is not reachable
+float compressedShortestPath(compressedGraph &cg, int source, int destination,
+	bool useHeuristic, vector<int> &parent, int &nodesExpanded)
+{
+	priority_queue< pair<float, int>, vector< pair<float, int> >, greater< pair<float, int> > > pqueue;
+	vector<float> dist(cg.numNodes, FLT_MAX);
+	vector<char> expanded(cg.numNodes, 0);
+	vector<int> ids;
+	vector<float> weights;
+
+	parent.assign(cg.numNodes, -1);
+	nodesExpanded = 0;
+	dist[source] = 0;
+	pqueue.push(make_pair(useHeuristic ? geoDistance(cg.location[source], cg.location[destination]) : 0, source));
+
+	while(!pqueue.empty())
+	{
+		int node = pqueue.top().second;
+		pqueue.pop();
+		if(expanded[node])
+			continue;
+		expanded[node] = 1;
+		nodesExpanded++;
+
+		if(node == destination)
+			return dist[node];
+
+		decodeNeighbours(cg, node, ids, weights);
+		for(size_t i=0; i<ids.size(); i++)
+		{
+			float distFromSource = dist[node] + weights[i];
+			if(distFromSource < dist[ids[i]])
+			{
+				dist[ids[i]] = distFromSource;
+				parent[ids[i]] = node;
+				float pathCost = distFromSource;
+				if(useHeuristic)
+					pathCost += geoDistance(cg.location[ids[i]], cg.location[destination]);
+				pqueue.push(make_pair(pathCost, ids[i]));
+			}
+		}
+	}
+
+	return -1;
+}
+
+//the search of compressedShortestPath on the uncompressed indexed graph,
+//the baseline for the cost of decoding
+float indexedShortestPath(indexedGraph &g, int source, int destination,
+	bool useHeuristic, vector<int> &parent, int &nodesExpanded)
+{
+	priority_queue< pair<float, int>, vector< pair<float, int> >, greater< pair<float, int> > > pqueue;
+	int numNodes = g.firstEdge.size() - 1;
+	vector<float> dist(numNodes, FLT_MAX);
+	vector<char> expanded(numNodes, 0);
+
+	parent.assign(numNodes, -1);
+	nodesExpanded = 0;
+	dist[source] = 0;
+	pqueue.push(make_pair(useHeuristic ? geoDistance(g.location[source], g.location[destination]) : 0, source));
+
+	while(!pqueue.empty())
+	{
+		int node = pqueue.top().second;
+		pqueue.pop();
+		if(expanded[node])
+			continue;
+		expanded[node] = 1;
+		nodesExpanded++;
+
+		if(node == destination)
+			return dist[node];
+
+		for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+		{
+			int v = g.edgeTarget[e];
+			float distFromSource = dist[node] + g.edgeWeight[e];
+			if(distFromSource < dist[v])
+			{
+				dist[v] = distFromSource;
+				parent[v] = node;
+				float pathCost = distFromSource;
+				if(useHeuristic)
+					pathCost += geoDistance(g.location[v], g.location[destination]);
+				pqueue.push(make_pair(pathCost, v));
+			}
+		}
+	}
+
+	return -1;
+}
+
+list<string> compressedSearch(string source, string destination)
+{
+	indexedGraph g;
+	compressedGraph cg;
+	vector<int> parent;
+	list<string> path;
+	int nodesExpanded;
+
+	buildIndexedGraph(g);
+	if(g.nodeIndex.find(source) == g.nodeIndex.end() || g.nodeIndex.find(destination) == g.nodeIndex.end())
+		return path;
+
+	//all distances of the built in graph are whole miles. Only the
+	//compressed graph is kept for the search
+	compressGraph(g, cg, 1.0);
+	g = indexedGraph();
+	graph.clear();
+	cityLocationMap.clear();
+
+	float distance = compressedShortestPath(cg, cg.nodeIndex[source], cg.nodeIndex[destination],
+		true, parent, nodesExpanded);
+	if(distance < 0)
+		return path;
+
+	cout<<"Number of nodes expanded are: "<<nodesExpanded<<endl<<endl;
+	cout<<"Compressed graph size: "<<compressedBytes(cg)<<" bytes for "<<cg.numEdges<<" edges"<<endl<<endl;
+
+	for(int node=cg.nodeIndex[destination]; node!=-1; node=parent[node])
+		path.push_front(cg.nodeName[node]);
+	totalDistance = distance;
+	return path;
+}
+
+//uniform cost search over the string keyed global graph, used as the
+//uncompressed reference by the benchmark
+float mapShortestPath(string source, string destination)
+{
+	priority_queue< pair<float, string>, vector< pair<float, string> >, greater< pair<float, string> > > pqueue;
+	map<string, float> dist;
+	map<string, int> expanded;
+	list<neighbourInfo>::iterator neighbourItr;
+
+	dist[source] = 0;
+	pqueue.push(make_pair(0.0f, source));
+	while(!pqueue.empty())
+	{
+		string node = pqueue.top().second;
+		pqueue.pop();
+		if(expanded.find(node) != expanded.end())
+			continue;
+		expanded[node] = 1;
+
+		if(node == destination)
+			return dist[node];
+
+		list<neighbourInfo> &neighbours = graph.find(node)->second;
+		for(neighbourItr=neighbours.begin(); neighbourItr!=neighbours.end(); neighbourItr++)
+		{
+			float distFromSource = dist[node] + (*neighbourItr).distance;
+			map<string, float>::iterator distItr = dist.find((*neighbourItr).cityName);
+			if(distItr == dist.end() || distFromSource < distItr->second)
+			{
+				dist[(*neighbourItr).cityName] = distFromSource;
+				pqueue.push(make_pair(distFromSource, (*neighbourItr).cityName));
+			}
+		}
+	}
+
+	return -1;
+}
+
+//compares memory and query time of the list based and the indexed
+//graph with the compressed graph on a synthetic side x side grid
+void compressBenchmark(int side, int numQueries)
+{
+	indexedGraph g;
+	compressedGraph cg;
+	vector<int> parent;
+	int nodesExpanded;
+
+	if(side < 2 || numQueries < 1)
+	{
+		cout<<"Please enter a grid side of at least 2 and at least one query\n";
+		return;
+	}
+
+	createSyntheticGraph(g, side, 1);
+	int numNodes = side * side;
+
+	//load the same graph in the list based representation
+	graph.clear();
+	vector<string> names(numNodes);
+	for(int node=0; node<numNodes; node++)
+		names[node] = "n" + to_string(node);
+	for(int u=0; u<numNodes; u++)
+		for(int e=g.firstEdge[u]; e<g.firstEdge[u + 1]; e++)
+			if(g.edgeTarget[e] > u)
+				addEdge(names[u], names[g.edgeTarget[e]], g.edgeWeight[e]);
+
+	//list node (two pointers), the neighbourInfo and a heap buffer for
+	//names that do not fit the small string buffer
+	long long listBytes = 0;
+	map< string, list<neighbourInfo> >::iterator graphItr;
+	list<neighbourInfo>::iterator neighbourItr;
+	for(graphItr=graph.begin(); graphItr!=graph.end(); graphItr++)
+	{
+		for(neighbourItr=graphItr->second.begin(); neighbourItr!=graphItr->second.end(); neighbourItr++)
+		{
+			const char *name = (*neighbourItr).cityName.data();
+			const char *object = (const char *)&(*neighbourItr).cityName;
+			listBytes += 2 * sizeof(void *) + sizeof(neighbourInfo);
+			if(name < object || name >= object + sizeof(string))
+				listBytes += (*neighbourItr).cityName.capacity() + 1;
+		}
+	}
+
+	//synthetic weights are multiples of 1/16 mile
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	compressGraph(g, cg, 1.0 / 16);
+	double compressMs = elapsedMs(start);
+
+	long long directedEdges = g.edgeTarget.size();
+	long long indexedBytes = g.firstEdge.size() * sizeof(int)
+		+ directedEdges * (sizeof(int) + sizeof(float));
+	cout<<"Nodes: "<<numNodes<<", undirected edges: "<<cg.numEdges<<endl;
+	cout<<"List graph bytes per directed edge: "<<(double)listBytes / directedEdges<<endl;
+	cout<<"Indexed graph bytes per directed edge: "<<(double)indexedBytes / directedEdges<<endl;
+	cout<<"Compressed graph bytes per directed edge: "<<(double)compressedBytes(cg) / directedEdges
+		<<" ("<<(double)compressedBytes(cg) / cg.numEdges<<" per undirected edge)"<<endl;
+	cout<<"Compression time: "<<compressMs<<" ms"<<endl;
+
+	//the indexed graph runs the same integer search without decoding, so
+	//compressed / indexed is the cost of the compression itself
+	double listMs = 0, indexedMs = 0, compressedMs = 0;
+	int mismatches = 0;
+	srand(2);
+	for(int query=0; query<numQueries; query++)
+	{
+		int source = rand() % numNodes;
+		int destination = rand() % numNodes;
+
+		start = chrono::steady_clock::now();
+		float listDistance = mapShortestPath(names[source], names[destination]);
+		listMs += elapsedMs(start);
+
+		start = chrono::steady_clock::now();
+		float indexedDistance = indexedShortestPath(g, source, destination, false, parent, nodesExpanded);
+		indexedMs += elapsedMs(start);
+
+		start = chrono::steady_clock::now();
+		float compressedDistance = compressedShortestPath(cg, source, destination, false, parent, nodesExpanded);
+		compressedMs += elapsedMs(start);
+
+		if(fabs(listDistance - compressedDistance) > 1e-3 * listDistance
+			|| fabs(indexedDistance - compressedDistance) > 1e-3 * indexedDistance)
+			mismatches++;
+	}
+
+	cout<<"List graph query time: "<<listMs / numQueries<<" ms (string keys)"<<endl;
+	cout<<"Indexed graph query time: "<<indexedMs / numQueries<<" ms"<<endl;
+	cout<<"Compressed graph query time: "<<compressedMs / numQueries<<" ms"<<endl;
+	cout<<"Compressed / indexed query time (slowdown): "<<compressedMs / indexedMs<<endl;
+	cout<<"Distance mismatches: "<<mismatches<<" of "<<numQueries<<endl;
+}
+
+double elapsedMs(chrono::steady_clock::time_point start)
+{
+	return chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+}
+
+//FNV-1a hash of node names and edges, stored with the all pairs table
+//so that a table saved for a different graph is never loaded
+uint64_t graphChecksum(indexedGraph &g)
+{
+	uint64_t hash = 14695981039346656037ULL;
+	int numNodes = g.firstEdge.size() - 1;
+
+	for(int node=0; node<numNodes; node++)
+	{
+		string name = g.nodeName.empty() ? "" : g.nodeName[node];
+		for(size_t i=0; i<=name.size(); i++)
+			hash = (hash ^ (uint8_t)name.c_str()[i]) * 1099511628211ULL;
+		for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+		{
+			uint32_t words[2];
+			words[0] = g.edgeTarget[e];
+			memcpy(&words[1], &g.edgeWeight[e], sizeof(float));
+			for(size_t i=0; i<sizeof(words); i++)
+				hash = (hash ^ ((uint8_t *)words)[i]) * 1099511628211ULL;
+		}
+	}
+	return hash;
+}
+
+//relaxes the tile of rows iBlock and columns jBlock through the
+//intermediate nodes of tile kBlock
+void floydWarshallTile(allPairsTable &table, int iBlock, int jBlock, int kBlock)
+{
+	int n = table.numNodes;
+	int iEnd = min(iBlock + ALL_PAIRS_TILE, n);
+	int jEnd = min(jBlock + ALL_PAIRS_TILE, n);
+	int kEnd = min(kBlock + ALL_PAIRS_TILE, n);
+
+	for(int k=kBlock; k<kEnd; k++)
+	{
+		float *rowK = &table.dist[(size_t)k * n];
+		for(int i=iBlock; i<iEnd; i++)
+		{
+			float distIK = table.dist[(size_t)i * n + k];
+			if(distIK == FLT_MAX)
+				continue;
+			int hop = table.nextHop[(size_t)i * n + k];
+			float *rowI = &table.dist[(size_t)i * n];
+			int *hopI = &table.nextHop[(size_t)i * n];
+			for(int j=jBlock; j<jEnd; j++)
+			{
+				if(distIK + rowK[j] < rowI[j])
+				{
+					rowI[j] = distIK + rowK[j];
+					hopI[j] = hop;
+				}
+			}
+		}
+	}
+}
+
+//blocked Floyd Warshall. For every diagonal tile the tile itself is
+//finished first, then the tiles sharing its rows or columns and finally
+//all the others, so every tile is loaded once per phase
+void computeAllPairs(indexedGraph &g, allPairsTable &table)
+{
+	int n = g.firstEdge.size() - 1;
+
+	table.numNodes = n;
+	table.dist.assign((size_t)n * n, FLT_MAX);
+	table.nextHop.assign((size_t)n * n, -1);
+	for(int u=0; u<n; u++)
+	{
+		table.dist[(size_t)u * n + u] = 0;
+		table.nextHop[(size_t)u * n + u] = u;
+		for(int e=g.firstEdge[u]; e<g.firstEdge[u + 1]; e++)
+		{
+			int v = g.edgeTarget[e];
+			if(g.edgeWeight[e] < table.dist[(size_t)u * n + v])
+			{
+				table.dist[(size_t)u * n + v] = g.edgeWeight[e];
+				table.nextHop[(size_t)u * n + v] = v;
+			}
+		}
+	}
+
+	for(int kBlock=0; kBlock<n; kBlock+=ALL_PAIRS_TILE)
+	{
+		floydWarshallTile(table, kBlock, kBlock, kBlock);
+		for(int block=0; block<n; block+=ALL_PAIRS_TILE)
+		{
+			if(block == kBlock)
+				continue;
+			floydWarshallTile(table, kBlock, block, kBlock);
+			floydWarshallTile(table, block, kBlock, kBlock);
+		}
+		for(int iBlock=0; iBlock<n; iBlock+=ALL_PAIRS_TILE)
+		{
+			if(iBlock == kBlock)
+				continue;
+			for(int jBlock=0; jBlock<n; jBlock+=ALL_PAIRS_TILE)
+				if(jBlock != kBlock)
+					floydWarshallTile(table, iBlock, jBlock, kBlock);
+		}
+	}
+}
+
+//writes the table to a temporary file of this process and renames it,
+//so that concurrent runs never read a partly written table
+bool saveAllPairs(allPairsTable &table, uint64_t checksum, string fileName)
+{
+	string tempName = fileName + "." + to_string(getpid()) + ".tmp";
+	bool written;
+	{
+		ofstream file(tempName.c_str(), ios::binary);
+		if(!file)
+			return false;
+
+		file.write(ALL_PAIRS_MAGIC, 4);
+		file.write((char *)&checksum, sizeof(checksum));
+		file.write((char *)&table.numNodes, sizeof(table.numNodes));
+		file.write((char *)&table.dist[0], table.dist.size() * sizeof(float));
+		file.write((char *)&table.nextHop[0], table.nextHop.size() * sizeof(int));
+		file.close();
+		written = !file.fail();
+	}
+
+	if(!written || rename(tempName.c_str(), fileName.c_str()) != 0)
+	{
+		remove(tempName.c_str());
+		return false;
+	}
+	return true;
+}
+
+//loads a saved table, fails if the file is missing, damaged or was
+//saved for a graph with a different checksum or number of nodes
+bool loadAllPairs(allPairsTable &table, uint64_t checksum, int numNodes, string fileName)
+{
+	ifstream file(fileName.c_str(), ios::binary);
+	char magic[4];
+	uint64_t savedChecksum;
+
+	if(!file)
+		return false;
+	file.read(magic, 4);
+	file.read((char *)&savedChecksum, sizeof(savedChecksum));
+	file.read((char *)&table.numNodes, sizeof(table.numNodes));
+	if(!file || memcmp(magic, ALL_PAIRS_MAGIC, 4) != 0 || savedChecksum != checksum
+		|| table.numNodes != numNodes || numNodes <= 0)
+		return false;
+
+	table.dist.resize((size_t)table.numNodes * table.numNodes);
+	table.nextHop.resize((size_t)table.numNodes * table.numNodes);
+	file.read((char *)&table.dist[0], table.dist.size() * sizeof(float));
+	file.read((char *)&table.nextHop[0], table.nextHop.size() * sizeof(int));
+	return file.good();
+}
+
+//loads the all pairs table of the global graph from disk, computing and
+//saving it first when there is no valid saved copy
+void loadOrComputeAllPairs(indexedGraph &g, allPairsTable &table)
+{
+	uint64_t checksum = graphChecksum(g);
+	if(loadAllPairs(table, checksum, g.firstEdge.size() - 1, ALL_PAIRS_FILE))
+		return;
+
+	computeAllPairs(g, table);
+	if(!saveAllPairs(table, checksum, ALL_PAIRS_FILE))
+		cout<<"Could not save all pairs table to "<<ALL_PAIRS_FILE<<endl<<endl;
+}
+
+//answers a query from the all pairs table: the distance is a single
+//lookup and the path is followed one next hop at a time
+list<string> allPairsSearch(string source, string destination)
+{
+	indexedGraph g;
+	allPairsTable table;
+	list<string> path;
+
+	buildIndexedGraph(g);
+	if(g.nodeIndex.find(source) == g.nodeIndex.end() || g.nodeIndex.find(destination) == g.nodeIndex.end())
+		return path;
+
+	loadOrComputeAllPairs(g, table);
+	int n = table.numNodes;
+	int node = g.nodeIndex[source];
+	int target = g.nodeIndex[destination];
+	if(table.dist[(size_t)node * n + target] == FLT_MAX)
+		return path;
+
+	cout<<"Path answered from the all pairs table"<<endl<<endl;
+	totalDistance = table.dist[(size_t)node * n + target];
+	path.push_back(g.nodeName[node]);
+	while(node != target)
+	{
+		node = table.nextHop[(size_t)node * n + target];
+		path.push_back(g.nodeName[node]);
+	}
+	return path;
+}
+
+//computes the all pairs table of the global graph and saves it
+void precomputeAllPairs()
+{
+	indexedGraph g;
+	allPairsTable table;
+
+	buildIndexedGraph(g);
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	computeAllPairs(g, table);
+	double computeMs = elapsedMs(start);
+
+	if(!saveAllPairs(table, graphChecksum(g), ALL_PAIRS_FILE))
+	{
+		cout<<"Could not save all pairs table to "<<ALL_PAIRS_FILE<<endl;
+		return;
+	}
+	cout<<"All pairs table for "<<table.numNodes<<" nodes computed in "<<computeMs<<" ms, "
+		<<table.dist.size() * (sizeof(float) + sizeof(int))<<" bytes saved to "<<ALL_PAIRS_FILE<<endl;
+}
+
+//uniform cost search from root to every node of g. dist is FLT_MAX and
+//parent -1 for unreachable nodes, parent of root is -1 as well. When a
+//destination is given the search stops once it is expanded
+void shortestPathTree(indexedGraph &g, int root, vector<float> &dist, vector<int> &parent, int destination)
+{
+	priority_queue< pair<float, int>, vector< pair<float, int> >, greater< pair<float, int> > > pqueue;
+	int numNodes = g.firstEdge.size() - 1;
+
+	dist.assign(numNodes, FLT_MAX);
+	parent.assign(numNodes, -1);
+	dist[root] = 0;
+	pqueue.push(make_pair(0.0f, root));
+	while(!pqueue.empty())
+	{
+		float distFromSource = pqueue.top().first;
+		int node = pqueue.top().second;
+		pqueue.pop();
+		if(distFromSource > dist[node])
+			continue;
+		if(node == destination)
+			break;
+
+		for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+		{
+			int v = g.edgeTarget[e];
+			if(distFromSource + g.edgeWeight[e] < dist[v])
+			{
+				dist[v] = distFromSource + g.edgeWeight[e];
+				parent[v] = node;
+				pqueue.push(make_pair(dist[v], v));
+			}
+		}
+	}
+}
+
+//weight of the shortest edge between u and v
+float indexedEdgeWeight(indexedGraph &g, int u, int v)
+{
+	float weight = FLT_MAX;
+	for(int e=g.firstEdge[u]; e<g.firstEdge[u + 1]; e++)
+		if(g.edgeTarget[e] == v && g.edgeWeight[e] < weight)
+			weight = g.edgeWeight[e];
+	return weight;
+}
+
+//finds the shortest path from the spur node of the task to the
+//destination that avoids the blocked nodes and does not leave the spur
+//node through one of blockedNext. With reuseTree the tree path is taken
+//when it is still allowed, otherwise Astar runs with the exact
+//distances of the unrestricted graph as heuristic
+bool spurSearch(spurTask &task, searchWorkspace &ws, int spur, vector<int> &blockedNext, vector<int> &spurPath, float &spurDist)
+{
+	indexedGraph &g = *task.g;
+	vector<float> &distToTarget = *task.distToTarget;
+	vector<int> &towardTarget = *task.towardTarget;
+	int destination = task.destination;
+	bool found = false;
+
+	spurPath.clear();
+	if(distToTarget[spur] == FLT_MAX)
+		return false;
+
+	if(task.reuseTree && find(blockedNext.begin(), blockedNext.end(), towardTarget[spur]) == blockedNext.end())
+	{
+		int node = spur;
+		while(node != -1 && !ws.blocked[node])
+		{
+			spurPath.push_back(node);
+			node = towardTarget[node];
+		}
+		if(node == -1)
+		{
+			spurDist = distToTarget[spur];
+			return true;
+		}
+		spurPath.clear();
+	}
+
+	priority_queue< pair<float, int>, vector< pair<float, int> >, greater< pair<float, int> > > pqueue;
+	ws.dist[spur] = 0;
+	ws.parent[spur] = -1;
+	ws.touched.push_back(spur);
+	pqueue.push(make_pair(task.reuseTree ? distToTarget[spur] : 0, spur));
+	while(!pqueue.empty())
+	{
+		int node = pqueue.top().second;
+		float pathCost = pqueue.top().first;
+		pqueue.pop();
+		if(pathCost > ws.dist[node] + (task.reuseTree ? distToTarget[node] : 0))
+			continue;
+		if(node == destination)
+		{
+			found = true;
+			break;
+		}
+
+		for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+		{
+			int v = g.edgeTarget[e];
+			if(ws.blocked[v] || distToTarget[v] == FLT_MAX)
+				continue;
+			if(node == spur && find(blockedNext.begin(), blockedNext.end(), v) != blockedNext.end())
+				continue;
+			float distFromSource = ws.dist[node] + g.edgeWeight[e];
+			if(distFromSource < ws.dist[v])
+			{
+				if(ws.dist[v] == FLT_MAX)
+					ws.touched.push_back(v);
+				ws.dist[v] = distFromSource;
+				ws.parent[v] = node;
+				pqueue.push(make_pair(distFromSource + (task.reuseTree ? distToTarget[v] : 0), v));
+			}
+		}
+	}
+
+	if(found)
+	{
+		spurDist = ws.dist[destination];
+		for(int node=destination; node!=-1; node=ws.parent[node])
+			spurPath.push_back(node);
+		reverse(spurPath.begin(), spurPath.end());
+	}
+
+	for(size_t i=0; i<ws.touched.size(); i++)
+		ws.dist[ws.touched[i]] = FLT_MAX;
+	ws.touched.clear();
+	return found;
+}
+
+//runs the spur searches of every numThreads-th spur node of the last
+//accepted path, starting with spur number threadIndex
+void spurWorker(spurTask *task, int threadIndex)
+{
+	rankedPath &last = task->accepted->back();
+	searchWorkspace &ws = (*task->workspaces)[threadIndex];
+	vector<int> blockedNext, spurPath;
+	float spurDist;
+
+	for(size_t spurIndex=task->firstSpur + threadIndex; spurIndex + 1<last.nodes.size(); spurIndex+=task->numThreads)
+	{
+		//edges leaving the spur node on accepted paths with the same root
+		blockedNext.clear();
+		for(size_t p=0; p<task->accepted->size(); p++)
+		{
+			vector<int> &nodes = (*task->accepted)[p].nodes;
+			if(nodes.size() > spurIndex + 1 && equal(nodes.begin(), nodes.begin() + spurIndex + 1, last.nodes.begin()))
+				blockedNext.push_back(nodes[spurIndex + 1]);
+		}
+
+		//the root nodes must not be visited again to keep the path loopless
+		for(size_t i=0; i<spurIndex; i++)
+			ws.blocked[last.nodes[i]] = 1;
+
+		rankedPath &candidate = (*task->spurPaths)[spurIndex - task->firstSpur];
+		candidate.distance = -1;
+		if(spurSearch(*task, ws, last.nodes[spurIndex], blockedNext, spurPath, spurDist))
+		{
+			candidate.distance = (*task->rootDist)[spurIndex] + spurDist;
+			candidate.deviation = spurIndex;
+			candidate.nodes.assign(last.nodes.begin(), last.nodes.begin() + spurIndex);
+			candidate.nodes.insert(candidate.nodes.end(), spurPath.begin(), spurPath.end());
+		}
+
+		for(size_t i=0; i<spurIndex; i++)
+			ws.blocked[last.nodes[i]] = 0;
+	}
+}
+
+//Yen's algorithm for the k shortest loopless paths from source to
+//destination, shortest first. With reuseTree the shortest path tree
+//towards destination guides every spur search, and only spur nodes from
+//the deviation node of the last accepted path onwards are searched
+//(Lawler), since the earlier ones were searched for its parent path
+void kShortestPaths(indexedGraph &g, int source, int destination, int k, bool reuseTree,
+	int numThreads, vector<rankedPath> &paths)
+{
+	vector<float> distToTarget;
+	vector<int> towardTarget;
+	map< pair< float, vector<int> >, int > candidates;
+	int numNodes = g.firstEdge.size() - 1;
+
+	paths.clear();
+	shortestPathTree(g, destination, distToTarget, towardTarget);
+	if(k < 1 || distToTarget[source] == FLT_MAX)
+		return;
+
+	rankedPath first;
+	first.distance = distToTarget[source];
+	first.deviation = 0;
+	for(int node=source; node!=-1; node=towardTarget[node])
+		first.nodes.push_back(node);
+	paths.push_back(first);
+
+	vector<searchWorkspace> workspaces(numThreads);
+	for(int t=0; t<numThreads; t++)
+	{
+		workspaces[t].dist.assign(numNodes, FLT_MAX);
+		workspaces[t].parent.assign(numNodes, -1);
+		workspaces[t].blocked.assign(numNodes, 0);
+	}
+
+	while((int)paths.size() < k)
+	{
+		rankedPath &last = paths.back();
+		vector<float> rootDist(last.nodes.size(), 0);
+		for(size_t i=1; i<last.nodes.size(); i++)
+			rootDist[i] = rootDist[i - 1] + indexedEdgeWeight(g, last.nodes[i - 1], last.nodes[i]);
+
+		spurTask task;
+		task.g = &g;
+		task.distToTarget = &distToTarget;
+		task.towardTarget = &towardTarget;
+		task.accepted = &paths;
+		task.workspaces = &workspaces;
+		task.rootDist = &rootDist;
+		task.destination = destination;
+		task.reuseTree = reuseTree;
+		task.firstSpur = reuseTree ? last.deviation : 0;
+		int numSpurs = last.nodes.size() - 1 - task.firstSpur;
+		task.numThreads = max(1, min(numThreads, numSpurs));
+		vector<rankedPath> spurPaths(max(numSpurs, 0));
+		task.spurPaths = &spurPaths;
+
+		vector<thread> threads;
+		for(int t=1; t<task.numThreads; t++)
+			threads.push_back(thread(spurWorker, &task, t));
+		spurWorker(&task, 0);
+		for(size_t t=0; t<threads.size(); t++)
+			threads[t].join();
+
+		for(size_t i=0; i<spurPaths.size(); i++)
+			if(spurPaths[i].distance >= 0)
+				candidates.insert(make_pair(make_pair(spurPaths[i].distance, spurPaths[i].nodes), spurPaths[i].deviation));
+
+		if(candidates.empty())
+			break;
+
+		rankedPath next;
+		next.distance = candidates.begin()->first.first;
+		next.nodes = candidates.begin()->first.second;
+		next.deviation = candidates.begin()->second;
+		candidates.erase(candidates.begin());
+		paths.push_back(next);
+	}
+}
+
+int defaultThreadCount()
+{
+	int numThreads = thread::hardware_concurrency();
+	return numThreads > 0 ? numThreads : 1;
+}
+
+//prints the k shortest paths between two cities of the global graph
+void kShortestSearch(string source, string destination, int k)
+{
+	indexedGraph g;
+	vector<rankedPath> paths;
+
+	buildIndexedGraph(g);
+	if(g.nodeIndex.find(source) == g.nodeIndex.end() || g.nodeIndex.find(destination) == g.nodeIndex.end())
+	{
+		cout<<"No path from source to destination"<<endl;
+		return;
+	}
+
+	kShortestPaths(g, g.nodeIndex[source], g.nodeIndex[destination], k, true, defaultThreadCount(), paths);
+	if(paths.empty())
+		cout<<"No path from source to destination"<<endl;
+
+	for(size_t p=0; p<paths.size(); p++)
+	{
+		cout<<"Path "<<p + 1<<" from source to destination is: ";
+		for(size_t i=0; i<paths[p].nodes.size(); i++)
+			cout<<g.nodeName[paths[p].nodes[i]]<<", ";
+		cout<<endl;
+		cout<<"Total distance of path "<<p + 1<<" is: "<<paths[p].distance<<endl<<endl;
+	}
+}
+
+//times k shortest path queries between random nodes of a synthetic
+//side x side grid with and without reuse of the shortest path tree
+void kShortestBenchmark(int side, int k)
+{
+	indexedGraph g;
+	vector<rankedPath> reusePaths, plainPaths;
+	int numQueries = 5;
+	int numThreads = defaultThreadCount();
+	double reuseMs = 0, plainMs = 0;
+	int mismatches = 0;
+
+	if(side < 2 || k < 1)
+	{
+		cout<<"Please enter a grid side of at least 2 and k of at least 1\n";
+		return;
+	}
+
+	createSyntheticGraph(g, side, 1);
+	srand(3);
+	for(int query=0; query<numQueries; query++)
+	{
+		int source = rand() % (side * side);
+		int destination = rand() % (side * side);
+
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		kShortestPaths(g, source, destination, k, true, numThreads, reusePaths);
+		reuseMs += elapsedMs(start);
+
+		start = chrono::steady_clock::now();
+		kShortestPaths(g, source, destination, k, false, numThreads, plainPaths);
+		plainMs += elapsedMs(start);
+
+		//ties may order equally long paths differently, the distances agree
+		if(reusePaths.size() != plainPaths.size())
+			mismatches++;
+		else
+			for(size_t p=0; p<reusePaths.size(); p++)
+				if(fabs(reusePaths[p].distance - plainPaths[p].distance) > 1e-3 * plainPaths[p].distance)
+				{
+					mismatches++;
+					break;
+				}
+	}
+
+	cout<<"Nodes: "<<side * side<<", k: "<<k<<", threads: "<<numThreads<<endl;
+	cout<<"Query time with tree reuse: "<<reuseMs / numQueries<<" ms"<<endl;
+	cout<<"Query time without tree reuse: "<<plainMs / numQueries<<" ms"<<endl;
+	cout<<"Queries with different distances: "<<mismatches<<" of "<<numQueries<<endl;
+}
+
+void barrierWait(threadBarrier &barrier)
+{
+	unique_lock<mutex> guard(barrier.lock);
+	int generation = barrier.generation;
+
+	if(++barrier.waiting == barrier.numThreads)
+	{
+		barrier.waiting = 0;
+		barrier.generation++;
+		barrier.released.notify_all();
+		return;
+	}
+	while(generation == barrier.generation)
+		barrier.released.wait(guard);
+}
+
+//a tentative distance and its parent packed in one word so that both
+//change together. Bit patterns of non negative floats order like the
+//floats, so packed values compare by distance first
+uint64_t packDistance(float dist, int parent)
+{
+	uint32_t bits;
+	memcpy(&bits, &dist, sizeof(bits));
+	return ((uint64_t)bits << 32) | (uint32_t)parent;
+}
+
+float unpackDistance(uint64_t packed)
+{
+	uint32_t bits = packed >> 32;
+	float dist;
+	memcpy(&dist, &bits, sizeof(dist));
+	return dist;
+}
+
+//relaxes the edges of node, improved neighbours go into the local bin
+//of their new distance
+void deltaSteppingRelax(deltaSteppingTask *task, int node, vector< vector<int> > &bins)
+{
+	indexedGraph &g = *task->g;
+	float distFromSource = unpackDistance(task->packed[node].load(memory_order_relaxed));
+
+	//entries left behind when the node moved to an earlier bin are stale.
+	//The bin is computed as in the relaxation so both agree at bin edges
+	if((size_t)(distFromSource / task->delta) < task->currentBin)
+		return;
+
+	for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+	{
+		int v = g.edgeTarget[e];
+		float newDist = distFromSource + g.edgeWeight[e];
+		uint64_t newPacked = packDistance(newDist, node);
+		uint64_t oldPacked = task->packed[v].load(memory_order_relaxed);
+		while(newPacked < oldPacked && unpackDistance(oldPacked) > newDist)
+		{
+			if(task->packed[v].compare_exchange_weak(oldPacked, newPacked, memory_order_relaxed))
+			{
+				size_t bin = (size_t)(newDist / task->delta);
+				if(bin >= bins.size())
+					bins.resize(bin + 1);
+				bins[bin].push_back(v);
+				break;
+			}
+		}
+	}
+}
+
+//one thread of the delta stepping search. In each round the threads
+//share the frontier of the current bin in chunks, keep relaxing their
+//own entries of that bin while they are few, then agree on the smallest
+//non empty bin and gather it into the next frontier
+void deltaSteppingWorker(deltaSteppingTask *task, int threadIndex)
+{
+	vector< vector<int> > bins;
+	vector<int> localFrontier;
+	int numNodes = task->packed.size();
+	int slice = (numNodes + task->numThreads - 1) / task->numThreads;
+	int sliceBegin = min(numNodes, threadIndex * slice);
+	int sliceEnd = min(numNodes, sliceBegin + slice);
+
+	for(int node=sliceBegin; node<sliceEnd; node++)
+		task->packed[node].store(packDistance(node == task->root ? 0 : FLT_MAX, -1), memory_order_relaxed);
+	barrierWait(task->barrier);
+
+	while(true)
+	{
+		size_t begin;
+		while((begin = task->nextIndex.fetch_add(DELTA_STEPPING_CHUNK)) < task->frontier.size())
+		{
+			size_t end = min(begin + DELTA_STEPPING_CHUNK, task->frontier.size());
+			for(size_t i=begin; i<end; i++)
+				deltaSteppingRelax(task, task->frontier[i], bins);
+		}
+
+		size_t currentBin = task->currentBin;
+		while(currentBin < bins.size() && !bins[currentBin].empty()
+			&& bins[currentBin].size() < DELTA_STEPPING_LOCAL_LIMIT)
+		{
+			localFrontier.swap(bins[currentBin]);
+			for(size_t i=0; i<localFrontier.size(); i++)
+				deltaSteppingRelax(task, localFrontier[i], bins);
+			localFrontier.clear();
+		}
+
+		for(size_t bin=currentBin; bin<bins.size(); bin++)
+		{
+			if(!bins[bin].empty())
+			{
+				size_t nextBin = task->nextBin.load();
+				while(bin < nextBin && !task->nextBin.compare_exchange_weak(nextBin, bin))
+					;
+				break;
+			}
+		}
+		barrierWait(task->barrier);
+
+		if(threadIndex == 0)
+		{
+			task->currentBin = task->nextBin.load();
+			task->nextBin.store(SIZE_MAX);
+		}
+		barrierWait(task->barrier);
+		if(task->currentBin == SIZE_MAX)
+			break;
+
+		currentBin = task->currentBin;
+		task->binCount[threadIndex] = currentBin < bins.size() ? bins[currentBin].size() : 0;
+		barrierWait(task->barrier);
+
+		if(threadIndex == 0)
+		{
+			size_t total = 0;
+			for(int t=0; t<task->numThreads; t++)
+			{
+				size_t count = task->binCount[t];
+				task->binCount[t] = total;
+				total += count;
+			}
+			task->frontier.resize(total);
+			task->nextIndex.store(0);
+		}
+		barrierWait(task->barrier);
+
+		if(currentBin < bins.size())
+		{
+			copy(bins[currentBin].begin(), bins[currentBin].end(), task->frontier.begin() + task->binCount[threadIndex]);
+			bins[currentBin].clear();
+		}
+		barrierWait(task->barrier);
+	}
+
+	for(int node=sliceBegin; node<sliceEnd; node++)
+	{
+		uint64_t packed = task->packed[node].load(memory_order_relaxed);
+		(*task->dist)[node] = unpackDistance(packed);
+		(*task->parent)[node] = (int)(uint32_t)packed;
+	}
+}
+
+//distances and parents from root to every node of g like
+//shortestPathTree, computed by delta stepping on numThreads threads.
+//Nodes are kept in bins of width delta and each bin is settled in
+//parallel rounds. Parents may differ from shortestPathTree on ties
+void deltaSteppingTree(indexedGraph &g, int root, float delta, int numThreads,
+	vector<float> &dist, vector<int> &parent)
+{
+	int numNodes = g.firstEdge.size() - 1;
+	deltaSteppingTask task(numNodes, numThreads);
+
+	dist.resize(numNodes);
+	parent.resize(numNodes);
+	task.g = &g;
+	task.root = root;
+	task.delta = delta;
+	task.dist = &dist;
+	task.parent = &parent;
+	task.frontier.push_back(root);
+	task.nextIndex.store(0);
+	task.currentBin = 0;
+	task.nextBin.store(SIZE_MAX);
+
+	vector<thread> threads;
+	for(int t=1; t<numThreads; t++)
+		threads.push_back(thread(deltaSteppingWorker, &task, t));
+	deltaSteppingWorker(&task, 0);
+	for(size_t t=0; t<threads.size(); t++)
+		threads[t].join();
+}
+
+//bin width used when none is given, a multiple of the mean edge weight
+float defaultDelta(indexedGraph &g)
+{
+	double total = 0;
+	for(size_t e=0; e<g.edgeWeight.size(); e++)
+		total += g.edgeWeight[e];
+	if(g.edgeWeight.empty() || total <= 0)
+		return 1;
+	return DELTA_STEPPING_FACTOR * total / g.edgeWeight.size();
+}
+
+//prints the distance from source to every city of the global graph
+void oneToAllSearch(string source)
+{
+	indexedGraph g;
+	vector<float> dist;
+	vector<int> parent;
+
+	buildIndexedGraph(g);
+	if(g.nodeIndex.find(source) == g.nodeIndex.end())
+	{
+		cout<<"Source is not in the graph"<<endl;
+		return;
+	}
+
+	deltaSteppingTree(g, g.nodeIndex[source], defaultDelta(g), defaultThreadCount(), dist, parent);
+	for(size_t node=0; node<g.nodeName.size(); node++)
+	{
+		cout<<g.nodeName[node]<<": ";
+		if(dist[node] == FLT_MAX)
+			cout<<"not reachable"<<endl;
+		else if(parent[node] == -1)
+			cout<<dist[node]<<endl;
+		else
+			cout<<dist[node]<<" via "<<g.nodeName[parent[node]]<<endl;
+	}
+}
+
+//times one full sweep from a random node of a synthetic side x side
+//grid, sequentially and with delta stepping on 1, 2, 4, .. maxThreads
+//threads, and checks every result against the sequential one
+void oneToAllBenchmark(int side, int maxThreads)
+{
+	indexedGraph g;
+	vector<float> referenceDist, dist;
+	vector<int> referenceParent, parent;
+
+	if(side < 2 || maxThreads < 1)
+	{
+		cout<<"Please enter a grid side of at least 2 and at least one thread\n";
+		return;
+	}
+
+	createSyntheticGraph(g, side, 1);
+	srand(4);
+	int root = rand() % (side * side);
+	float delta = defaultDelta(g);
+	cout<<"Nodes: "<<side * side<<", directed edges: "<<g.edgeTarget.size()<<", delta: "<<delta<<endl;
+
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	shortestPathTree(g, root, referenceDist, referenceParent);
+	double sequentialMs = elapsedMs(start);
+	cout<<"Sequential Dijkstra: "<<sequentialMs<<" ms"<<endl;
+
+	for(int numThreads=1; ; numThreads=min(2 * numThreads, maxThreads))
+	{
+		start = chrono::steady_clock::now();
+		deltaSteppingTree(g, root, delta, numThreads, dist, parent);
+		double parallelMs = elapsedMs(start);
+
+		//distances must match and every parent edge must be tight
+		int mismatches = 0;
+		for(size_t node=0; node<dist.size(); node++)
+		{
+			if(fabs(dist[node] - referenceDist[node]) > 1e-3 * referenceDist[node])
+				mismatches++;
+			else if(parent[node] != -1
+				&& fabs(dist[parent[node]] + indexedEdgeWeight(g, parent[node], node) - dist[node]) > 1e-3 * dist[node])
+				mismatches++;
+		}
+
+		cout<<"Delta stepping, "<<numThreads<<" threads: "<<parallelMs<<" ms, speedup "
+			<<sequentialMs / parallelMs<<", mismatches "<<mismatches<<endl;
+		if(numThreads == maxThreads)
+			break;
+	}
+}
+
+//splits order[begin .. end-1] at the median of the coordinate with the
+//larger spread, depth times, and gives every node the bit path of its
+//final part as cell code
+void partitionNodes(indexedGraph &g, vector<int> &order, int begin, int end, int depth, int code, vector<int> &cellCode)
+{
+	if(depth == 0 || end - begin < 2)
+	{
+		for(int i=begin; i<end; i++)
+			cellCode[order[i]] = code << depth;
+		return;
+	}
+
+	float minLat = FLT_MAX, maxLat = -FLT_MAX, minLong = FLT_MAX, maxLong = -FLT_MAX;
+	for(int i=begin; i<end; i++)
+	{
+		minLat = min(minLat, g.location[order[i]].latitude);
+		maxLat = max(maxLat, g.location[order[i]].latitude);
+		minLong = min(minLong, g.location[order[i]].longitude);
+		maxLong = max(maxLong, g.location[order[i]].longitude);
+	}
+
+	locationCompare compare;
+	compare.g = &g;
+	compare.byLatitude = (maxLat - minLat) > (maxLong - minLong);
+	int middle = begin + (end - begin) / 2;
+	nth_element(order.begin() + begin, order.begin() + middle, order.begin() + end, compare);
+
+	partitionNodes(g, order, begin, middle, depth - 1, 2 * code, cellCode);
+	partitionNodes(g, order, middle, end, depth - 1, 2 * code + 1, cellCode);
+}
+
+//partitions g geometrically into cells of at most cellSize nodes and
+//groups OVERLAY_LEVEL_BITS levels of bisection into each overlay level,
+//so every cell holds 2^OVERLAY_LEVEL_BITS cells of the level below.
+//Levels whose cells would exceed OVERLAY_MAX_CELL_SIZE nodes are left out
+//since they cost most of the customization time. Shortcut weights are
+//left for customizeOverlay
+void buildOverlay(overlayGraph &overlay, indexedGraph &g, int cellSize)
+{
+	int numNodes = g.firstEdge.size() - 1;
+	vector<int> order(numNodes), cellCode(numNodes);
+
+	int depth = 1;
+	while(((long long)numNodes >> depth) >= cellSize)
+		depth++;
+	for(int node=0; node<numNodes; node++)
+		order[node] = node;
+	partitionNodes(g, order, 0, numNodes, depth, 0, cellCode);
+
+	int numLevels = 1;
+	while(numLevels * OVERLAY_LEVEL_BITS < depth
+		&& ((long long)numNodes >> (depth - numLevels * OVERLAY_LEVEL_BITS)) <= OVERLAY_MAX_CELL_SIZE)
+		numLevels++;
+
+	overlay.g = &g;
+	overlay.levels.assign(numLevels, overlayLevel());
+	for(size_t level=0; level<overlay.levels.size(); level++)
+	{
+		overlayLevel &lv = overlay.levels[level];
+		int shift = level * OVERLAY_LEVEL_BITS;
+
+		lv.numCells = 1 << (depth - shift);
+		lv.cell.resize(numNodes);
+		for(int node=0; node<numNodes; node++)
+			lv.cell[node] = cellCode[node] >> shift;
+
+		//boundary nodes have an edge leaving their cell
+		lv.boundary.assign(lv.numCells, vector<int>());
+		lv.boundaryIndex.assign(numNodes, -1);
+		for(int node=0; node<numNodes; node++)
+		{
+			for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+			{
+				if(lv.cell[g.edgeTarget[e]] != lv.cell[node])
+				{
+					lv.boundaryIndex[node] = lv.boundary[lv.cell[node]].size();
+					lv.boundary[lv.cell[node]].push_back(node);
+					break;
+				}
+			}
+		}
+
+		lv.clique.resize(lv.numCells);
+		for(int cell=0; cell<lv.numCells; cell++)
+			lv.clique[cell].assign(lv.boundary[cell].size() * lv.boundary[cell].size(), FLT_MAX);
+		lv.dirty.assign(lv.numCells, 1);
+		lv.changed.assign(lv.numCells, 0);
+		lv.customizeMs = 0;
+		lv.customizedCells = 0;
+	}
+
+	for(int dir=0; dir<2; dir++)
+	{
+		overlay.dist[dir].assign(numNodes, FLT_MAX);
+		overlay.parent[dir].assign(numNodes, -1);
+		overlay.parentLevel[dir].assign(numNodes, -1);
+		overlay.touched[dir].clear();
+	}
+	overlay.unpack.dist.assign(numNodes, FLT_MAX);
+	overlay.unpack.parent.assign(numNodes, -1);
+	overlay.unpack.touched.clear();
+}
+
+//computes the shortcut weights of one cell, the distances between its
+//boundary nodes inside the cell. Level 0 searches the original graph,
+//higher levels the shortcuts of the level below and the original edges
+//between its cells
+void customizeCell(overlayGraph &overlay, int level, int cell, searchWorkspace &ws)
+{
+	indexedGraph &g = *overlay.g;
+	overlayLevel &lv = overlay.levels[level];
+	vector<int> &boundary = lv.boundary[cell];
+	int numBoundary = boundary.size();
+
+	for(int b=0; b<numBoundary; b++)
+	{
+		overlayQueue pqueue;
+		int remaining = numBoundary;
+		ws.dist[boundary[b]] = 0;
+		ws.touched.push_back(boundary[b]);
+		pqueue.push(make_pair(0.0f, boundary[b]));
+
+		//stops once every boundary node of the cell is expanded
+		while(!pqueue.empty())
+		{
+			float distFromSource = pqueue.top().first;
+			int node = pqueue.top().second;
+			pqueue.pop();
+			if(distFromSource > ws.dist[node])
+				continue;
+			if(lv.boundaryIndex[node] >= 0 && --remaining == 0)
+				break;
+
+			if(level > 0)
+			{
+				overlayLevel &lower = overlay.levels[level - 1];
+				int lowerCell = lower.cell[node];
+				vector<int> &lowerBoundary = lower.boundary[lowerCell];
+				float *row = &lower.clique[lowerCell][(size_t)lower.boundaryIndex[node] * lowerBoundary.size()];
+				for(size_t j=0; j<lowerBoundary.size(); j++)
+				{
+					int v = lowerBoundary[j];
+					if(distFromSource + row[j] < ws.dist[v])
+					{
+						if(ws.dist[v] == FLT_MAX)
+							ws.touched.push_back(v);
+						ws.dist[v] = distFromSource + row[j];
+						pqueue.push(make_pair(ws.dist[v], v));
+					}
+				}
+			}
+
+			for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+			{
+				int v = g.edgeTarget[e];
+				if(lv.cell[v] != cell)
+					continue;
+				if(level > 0 && overlay.levels[level - 1].cell[v] == overlay.levels[level - 1].cell[node])
+					continue;
+				if(distFromSource + g.edgeWeight[e] < ws.dist[v])
+				{
+					if(ws.dist[v] == FLT_MAX)
+						ws.touched.push_back(v);
+					ws.dist[v] = distFromSource + g.edgeWeight[e];
+					pqueue.push(make_pair(ws.dist[v], v));
+				}
+			}
+		}
+
+		for(int j=0; j<numBoundary; j++)
+			lv.clique[cell][(size_t)b * numBoundary + j] = ws.dist[boundary[j]];
+		for(size_t i=0; i<ws.touched.size(); i++)
+			ws.dist[ws.touched[i]] = FLT_MAX;
+		ws.touched.clear();
+	}
+}
+
+//customizes the dirty cells of one level, taking cells one at a time,
+//and notes which of them got different shortcut weights
+void customizeWorker(customizeTask *task, int threadIndex)
+{
+	overlayLevel &lv = task->overlay->levels[task->level];
+	searchWorkspace &ws = (*task->workspaces)[threadIndex];
+	vector<float> previous;
+	int cell;
+
+	while((cell = task->nextCell.fetch_add(1)) < lv.numCells)
+	{
+		lv.changed[cell] = 0;
+		if(!lv.dirty[cell])
+			continue;
+		previous = lv.clique[cell];
+		customizeCell(*task->overlay, task->level, cell, ws);
+		lv.changed[cell] = previous != lv.clique[cell];
+	}
+}
+
+//recomputes the shortcut weights of all dirty cells, level by level since
+//every level is built from the one below. A cell of the next level only
+//becomes dirty when the shortcuts of one of its subcells changed. Returns
+//the number of cells customized
+int customizeOverlay(overlayGraph &overlay, int numThreads)
+{
+	int numNodes = overlay.g->firstEdge.size() - 1;
+	int customized = 0;
+	vector<searchWorkspace> workspaces(numThreads);
+
+	for(int t=0; t<numThreads; t++)
+		workspaces[t].dist.assign(numNodes, FLT_MAX);
+
+	for(size_t level=0; level<overlay.levels.size(); level++)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		customizeTask task;
+		task.overlay = &overlay;
+		task.level = level;
+		task.workspaces = &workspaces;
+		task.nextCell.store(0);
+
+		vector<thread> threads;
+		for(int t=1; t<numThreads; t++)
+			threads.push_back(thread(customizeWorker, &task, t));
+		customizeWorker(&task, 0);
+		for(size_t t=0; t<threads.size(); t++)
+			threads[t].join();
+
+		overlayLevel &lv = overlay.levels[level];
+		lv.customizedCells = 0;
+		for(int cell=0; cell<lv.numCells; cell++)
+		{
+			lv.customizedCells += lv.dirty[cell];
+			if(lv.changed[cell] && level + 1 < overlay.levels.size())
+				overlay.levels[level + 1].dirty[cell >> OVERLAY_LEVEL_BITS] = 1;
+			lv.dirty[cell] = 0;
+		}
+		lv.customizeMs = elapsedMs(start);
+		customized += lv.customizedCells;
+	}
+	return customized;
+}
+
+//changes the weight of the edge between u and v and marks the smallest
+//cell containing both end points dirty. Larger cells are only customized
+//again if the shortcuts of that cell change
+void updateOverlayWeight(overlayGraph &overlay, int u, int v, float distance)
+{
+	indexedGraph &g = *overlay.g;
+
+	for(int e=g.firstEdge[u]; e<g.firstEdge[u + 1]; e++)
+		if(g.edgeTarget[e] == v)
+			g.edgeWeight[e] = distance;
+	for(int e=g.firstEdge[v]; e<g.firstEdge[v + 1]; e++)
+		if(g.edgeTarget[e] == u)
+			g.edgeWeight[e] = distance;
+
+	for(size_t level=0; level<overlay.levels.size(); level++)
+	{
+		overlayLevel &lv = overlay.levels[level];
+		if(lv.cell[u] == lv.cell[v])
+		{
+			lv.dirty[lv.cell[u]] = 1;
+			break;
+		}
+	}
+}
+
+//highest level at which node is in neither the source nor the destination
+//cell, -1 when it shares the lowest level cell with one of them
+int queryLevel(overlayGraph &overlay, int node, int source, int destination)
+{
+	for(size_t level=0; level<overlay.levels.size(); level++)
+	{
+		vector<int> &cell = overlay.levels[level].cell;
+		if(cell[node] == cell[source] || cell[node] == cell[destination])
+			return level - 1;
+	}
+	return overlay.levels.size() - 1;
+}
+
+void overlayRelax(overlayGraph &overlay, int dir, int node, int v, float distance, int level,
+	overlayQueue &pqueue, float &bestDist, int &meetNode)
+{
+	float distFromSource = overlay.dist[dir][node] + distance;
+	if(distFromSource >= overlay.dist[dir][v])
+		return;
+
+	if(overlay.dist[dir][v] == FLT_MAX)
+		overlay.touched[dir].push_back(v);
+	overlay.dist[dir][v] = distFromSource;
+	overlay.parent[dir][v] = node;
+	overlay.parentLevel[dir][v] = level;
+	pqueue.push(make_pair(distFromSource, v));
+
+	if(overlay.dist[1 - dir][v] != FLT_MAX && distFromSource + overlay.dist[1 - dir][v] < bestDist)
+	{
+		bestDist = distFromSource + overlay.dist[1 - dir][v];
+		meetNode = v;
+	}
+}
+
+//shortest path between a and b inside the given cell of the given level,
+//used to expand a shortcut into original edges. Appends the nodes after a
+void cellPath(overlayGraph &overlay, int level, int a, int b, vector<int> &path)
+{
+	indexedGraph &g = *overlay.g;
+	searchWorkspace &ws = overlay.unpack;
+	vector<int> &cell = overlay.levels[level].cell;
+	overlayQueue pqueue;
+
+	ws.dist[a] = 0;
+	ws.parent[a] = -1;
+	ws.touched.push_back(a);
+	pqueue.push(make_pair(0.0f, a));
+	while(!pqueue.empty())
+	{
+		float distFromSource = pqueue.top().first;
+		int node = pqueue.top().second;
+		pqueue.pop();
+		if(distFromSource > ws.dist[node])
+			continue;
+		if(node == b)
+			break;
+
+		for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+		{
+			int v = g.edgeTarget[e];
+			if(cell[v] != cell[a])
+				continue;
+			if(distFromSource + g.edgeWeight[e] < ws.dist[v])
+			{
+				if(ws.dist[v] == FLT_MAX)
+					ws.touched.push_back(v);
+				ws.dist[v] = distFromSource + g.edgeWeight[e];
+				ws.parent[v] = node;
+				pqueue.push(make_pair(ws.dist[v], v));
+			}
+		}
+	}
+
+	size_t first = path.size();
+	for(int node=b; node!=a; node=ws.parent[node])
+		path.push_back(node);
+	reverse(path.begin() + first, path.end());
+
+	for(size_t i=0; i<ws.touched.size(); i++)
+		ws.dist[ws.touched[i]] = FLT_MAX;
+	ws.touched.clear();
+}
+
+//bidirectional search on the overlay. Each search uses the original edges
+//around the source and destination and the shortcuts of ever coarser
+//cells further away. Returns the distance or -1 when destination is not
+//reachable, and the path in original nodes when path is not NULL
+float overlayQuery(overlayGraph &overlay, int source, int destination, vector<int> *path)
+{
+	indexedGraph &g = *overlay.g;
+	overlayQueue pqueue[2];
+	float bestDist = FLT_MAX;
+	int meetNode = -1;
+	int ends[2] = {source, destination};
+
+	for(int dir=0; dir<2; dir++)
+	{
+		overlay.dist[dir][ends[dir]] = 0;
+		overlay.parent[dir][ends[dir]] = -1;
+		overlay.touched[dir].push_back(ends[dir]);
+		pqueue[dir].push(make_pair(0.0f, ends[dir]));
+	}
+	if(source == destination)
+	{
+		bestDist = 0;
+		meetNode = source;
+	}
+
+	while(!pqueue[0].empty() && !pqueue[1].empty() && pqueue[0].top().first + pqueue[1].top().first < bestDist)
+	{
+		int dir = pqueue[0].top().first <= pqueue[1].top().first ? 0 : 1;
+		float distFromSource = pqueue[dir].top().first;
+		int node = pqueue[dir].top().second;
+		pqueue[dir].pop();
+		if(distFromSource > overlay.dist[dir][node])
+			continue;
+
+		int level = queryLevel(overlay, node, source, destination);
+		if(level >= 0)
+		{
+			overlayLevel &lv = overlay.levels[level];
+			vector<int> &boundary = lv.boundary[lv.cell[node]];
+			float *row = &lv.clique[lv.cell[node]][(size_t)lv.boundaryIndex[node] * boundary.size()];
+			for(size_t j=0; j<boundary.size(); j++)
+				if(row[j] != FLT_MAX)
+					overlayRelax(overlay, dir, node, boundary[j], row[j], level, pqueue[dir], bestDist, meetNode);
+		}
+
+		for(int e=g.firstEdge[node]; e<g.firstEdge[node + 1]; e++)
+		{
+			int v = g.edgeTarget[e];
+			if(level < 0 || overlay.levels[level].cell[v] != overlay.levels[level].cell[node])
+				overlayRelax(overlay, dir, node, v, g.edgeWeight[e], -1, pqueue[dir], bestDist, meetNode);
+		}
+	}
+
+	if(path != NULL && meetNode != -1)
+	{
+		vector<int> forward, backward;
+		for(int node=meetNode; node!=-1; node=overlay.parent[0][node])
+			forward.push_back(node);
+		for(int node=meetNode; node!=-1; node=overlay.parent[1][node])
+			backward.push_back(node);
+
+		path->assign(1, source);
+		for(size_t i=forward.size() - 1; i>0; i--)
+		{
+			int level = overlay.parentLevel[0][forward[i - 1]];
+			if(level < 0)
+				path->push_back(forward[i - 1]);
+			else
+				cellPath(overlay, level, forward[i], forward[i - 1], *path);
+		}
+		for(size_t i=0; i + 1<backward.size(); i++)
+		{
+			int level = overlay.parentLevel[1][backward[i]];
+			if(level < 0)
+				path->push_back(backward[i + 1]);
+			else
+				cellPath(overlay, level, backward[i], backward[i + 1], *path);
+		}
+	}
+
+	for(int dir=0; dir<2; dir++)
+	{
+		for(size_t i=0; i<overlay.touched[dir].size(); i++)
+			overlay.dist[dir][overlay.touched[dir][i]] = FLT_MAX;
+		overlay.touched[dir].clear();
+	}
+	return meetNode == -1 ? -1 : bestDist;
+}
+
+list<string> overlaySearch(string source, string destination)
+{
+	indexedGraph g;
+	overlayGraph overlay;
+	vector<int> nodes;
+	list<string> path;
+
+	buildIndexedGraph(g);
+	if(g.nodeIndex.find(source) == g.nodeIndex.end() || g.nodeIndex.find(destination) == g.nodeIndex.end())
+		return path;
+
+	buildOverlay(overlay, g, OVERLAY_USA_CELL_SIZE);
+	customizeOverlay(overlay, defaultThreadCount());
+	float distance = overlayQuery(overlay, g.nodeIndex[source], g.nodeIndex[destination], &nodes);
+	if(distance < 0)
+		return path;
+
+	for(size_t i=0; i<nodes.size(); i++)
+		path.push_back(g.nodeName[nodes[i]]);
+	totalDistance = distance;
+	return path;
+}
+
+//time and number of cells of the last customization of every level
+void printCustomization(overlayGraph &overlay)
+{
+	for(size_t level=0; level<overlay.levels.size(); level++)
+		cout<<"  level "<<level<<": "<<overlay.levels[level].customizeMs<<" ms, "
+			<<overlay.levels[level].customizedCells<<" of "<<overlay.levels[level].numCells<<" cells"<<endl;
+}
+
+//runs the queries on the overlay and with uniform cost search, adds the
+//times and returns the number of different distances
+int overlayQueries(overlayGraph &overlay, vector< pair<int, int> > &queries, double &overlayMs, double &uniformMs)
+{
+	vector<float> dist;
+	vector<int> parent;
+	int mismatches = 0;
+
+	overlayMs = uniformMs = 0;
+	for(size_t i=0; i<queries.size(); i++)
+	{
+		chrono::steady_clock::time_point start = chrono::steady_clock::now();
+		float overlayDistance = overlayQuery(overlay, queries[i].first, queries[i].second, NULL);
+		overlayMs += elapsedMs(start);
+
+		start = chrono::steady_clock::now();
+		shortestPathTree(*overlay.g, queries[i].first, dist, parent, queries[i].second);
+		uniformMs += elapsedMs(start);
+
+		float uniformDistance = dist[queries[i].second] == FLT_MAX ? -1 : dist[queries[i].second];
+		if(fabs(overlayDistance - uniformDistance) > 1e-3 * fabs(uniformDistance))
+			mismatches++;
+	}
+	return mismatches;
+}
+
+//builds the overlay of a thinned side x side grid (createRoadGraph) and reports
+//customization time, query latency and exactness against uniform cost
+//search, before and after congesting random edges
+void overlayBenchmark(int side, int numQueries)
+{
+	indexedGraph g;
+	overlayGraph overlay;
+	vector< pair<int, int> > queries;
+	double overlayMs, uniformMs;
+	int numThreads = defaultThreadCount();
+	int numCongested = 10;
+
+	if(side < 2 || numQueries < 1)
+	{
+		cout<<"Please enter a grid side of at least 2 and at least one query\n";
+		return;
+	}
+
+	createRoadGraph(g, side, OVERLAY_ROAD_SPACING, 1);
+	int numNodes = g.firstEdge.size() - 1;
+	chrono::steady_clock::time_point start = chrono::steady_clock::now();
+	buildOverlay(overlay, g, OVERLAY_CELL_SIZE);
+	double partitionMs = elapsedMs(start);
+
+	cout<<"Nodes: "<<numNodes<<", threads: "<<numThreads<<endl;
+	cout<<"Partition time: "<<partitionMs<<" ms"<<endl;
+	for(size_t level=0; level<overlay.levels.size(); level++)
+	{
+		long long numBoundary = 0, numShortcuts = 0;
+		for(int cell=0; cell<overlay.levels[level].numCells; cell++)
+		{
+			numBoundary += overlay.levels[level].boundary[cell].size();
+			numShortcuts += overlay.levels[level].clique[cell].size();
+		}
+		cout<<"Level "<<level<<": "<<overlay.levels[level].numCells<<" cells, "<<numBoundary
+			<<" boundary nodes, "<<numShortcuts<<" shortcuts"<<endl;
+	}
+
+	start = chrono::steady_clock::now();
+	int customized = customizeOverlay(overlay, numThreads);
+	cout<<"Full customization: "<<elapsedMs(start)<<" ms, "<<customized<<" cells"<<endl;
+	printCustomization(overlay);
+
+	srand(5);
+	for(int i=0; i<numQueries; i++)
+		queries.push_back(make_pair(rand() % numNodes, rand() % numNodes));
+	int mismatches = overlayQueries(overlay, queries, overlayMs, uniformMs);
+	cout<<"Overlay query time: "<<overlayMs / numQueries<<" ms, uniform: "<<uniformMs / numQueries
+		<<" ms, mismatches: "<<mismatches<<" of "<<numQueries<<endl;
+
+	//congestion triples the weight of random edges
+	for(int i=0; i<numCongested; i++)
+	{
+		int u = rand() % numNodes;
+		if(g.firstEdge[u] == g.firstEdge[u + 1])
+			continue;
+		int e = g.firstEdge[u] + rand() % (g.firstEdge[u + 1] - g.firstEdge[u]);
+		updateOverlayWeight(overlay, u, g.edgeTarget[e], 3 * g.edgeWeight[e]);
+	}
+
+	start = chrono::steady_clock::now();
+	customized = customizeOverlay(overlay, numThreads);
+	cout<<"Customization after congesting "<<numCongested<<" edges: "<<elapsedMs(start)<<" ms, "
+		<<customized<<" cells"<<endl;
+	printCustomization(overlay);
+
+	mismatches = overlayQueries(overlay, queries, overlayMs, uniformMs);
+	cout<<"Overlay query time: "<<overlayMs / numQueries<<" ms, uniform: "<<uniformMs / numQueries
+		<<" ms, mismatches: "<<mismatches<<" of "<<numQueries<<endl;
+}
+
+void addEdge(string u, string v, float distance)
+{
+	neighbourInfo neighbourInfoVar;
+	neighbourInfoVar.cityName = v;
+	neighbourInfoVar.distance = distance;
+	graph[u].push_back(neighbourInfoVar);
+
+	neighbourInfoVar.cityName = u;
+	graph[v].push_back(neighbourInfoVar);
+}
+
+void addLocation(string cityName, float latitude, float longitude)
+{
+	cityLocation cityLocationVar;
+	cityLocationVar.latitude = latitude;
+	cityLocationVar.longitude = longitude;
+	cityLocationMap[cityName] = cityLocationVar;
+}
+
+float calculateHeuristic(string source, string destination)
+{
+	return geoDistance(cityLocationMap[source], cityLocationMap[destination]);
+}
+
+//straight line distance in miles between two locations
+float geoDistance(cityLocation a, cityLocation b)
 {
-	float lat1 = cityLocationMap[source].latitude;
-	float long1 = cityLocationMap[source].longitude;
+	float lat1 = a.latitude;
+	float long1 = a.longitude;
 
-	float lat2 = cityLocationMap[destination].latitude;
-	float long2 = cityLocationMap[destination].longitude;
+	float lat2 = b.latitude;
+	float long2 = b.longitude;
 	float pi = 3.141593;
 
 	float heuristic = sqrt(pow((69.5 * (lat1 - lat2)), 2.0) 